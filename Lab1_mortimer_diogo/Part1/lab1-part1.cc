@@ -4,6 +4,10 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 //
 //       10.1.2.0          10.1.1.0
 // n2 -------------- n0 -------------- n1
@@ -19,23 +23,320 @@ using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("Lab1Part1");
 
+const double LOAD_START_TIME = 2.0;
+const double LOAD_DRAIN_TIME = 2.0;
+
+// Open-loop UDP request generator used in load mode. Every request carries a
+// SeqTsHeader that the echo server reflects unchanged, so the round-trip
+// latency of each request is measured when its echo comes back.
+class LoadClient : public Application
+{
+public:
+  LoadClient ();
+  virtual ~LoadClient ();
+
+  static TypeId GetTypeId (void);
+  void Setup (Address peer, uint32_t packetSize, double packetRate,
+              std::string arrival, double onTime, double offTime, Time txStop);
+
+  uint32_t GetSent (void) const;
+  uint32_t GetReceived (void) const;
+  uint64_t GetWindowRxBytes (void) const;
+  const std::vector<double> &GetLatencies (void) const;
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  Time NextInterval (void);
+  void ScheduleNextTx (void);
+  void SendPacket (void);
+  void ToggleOnOff (void);
+  void HandleRead (Ptr<Socket> socket);
+
+  Ptr<Socket> m_socket;
+  Address m_peer;
+  uint32_t m_packetSize;
+  double m_packetRate;
+  std::string m_arrival;
+  double m_onTime;
+  double m_offTime;
+  Time m_txStop;
+  bool m_running;
+  bool m_on;
+  EventId m_sendEvent;
+  EventId m_toggleEvent;
+  Ptr<ExponentialRandomVariable> m_interArrival;
+  Ptr<ExponentialRandomVariable> m_onPeriod;
+  Ptr<ExponentialRandomVariable> m_offPeriod;
+  uint32_t m_sent;
+  uint32_t m_received;
+  uint64_t m_windowRxBytes;
+  std::vector<double> m_latencies;
+};
+
+LoadClient::LoadClient ()
+  : m_socket (0),
+    m_peer (),
+    m_packetSize (0),
+    m_packetRate (0),
+    m_onTime (0),
+    m_offTime (0),
+    m_running (false),
+    m_on (false),
+    m_sent (0),
+    m_received (0),
+    m_windowRxBytes (0)
+{
+}
+
+LoadClient::~LoadClient ()
+{
+  m_socket = 0;
+}
+
+TypeId
+LoadClient::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("LoadClient")
+    .SetParent<Application> ()
+    .SetGroupName ("Lab1")
+    .AddConstructor<LoadClient> ()
+    ;
+  return tid;
+}
+
+void
+LoadClient::Setup (Address peer, uint32_t packetSize, double packetRate,
+                   std::string arrival, double onTime, double offTime, Time txStop)
+{
+  m_peer = peer;
+  m_packetSize = packetSize;
+  m_packetRate = packetRate;
+  m_arrival = arrival;
+  m_onTime = onTime;
+  m_offTime = offTime;
+  m_txStop = txStop;
+
+  m_interArrival = CreateObject<ExponentialRandomVariable> ();
+  m_interArrival->SetAttribute ("Mean", DoubleValue (1.0 / packetRate));
+  m_onPeriod = CreateObject<ExponentialRandomVariable> ();
+  m_onPeriod->SetAttribute ("Mean", DoubleValue (onTime));
+  m_offPeriod = CreateObject<ExponentialRandomVariable> ();
+  m_offPeriod->SetAttribute ("Mean", DoubleValue (offTime));
+}
+
+uint32_t
+LoadClient::GetSent (void) const
+{
+  return m_sent;
+}
+
+uint32_t
+LoadClient::GetReceived (void) const
+{
+  return m_received;
+}
+
+uint64_t
+LoadClient::GetWindowRxBytes (void) const
+{
+  return m_windowRxBytes;
+}
+
+const std::vector<double> &
+LoadClient::GetLatencies (void) const
+{
+  return m_latencies;
+}
+
+void
+LoadClient::StartApplication (void)
+{
+  m_running = true;
+  m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
+  m_socket->Bind ();
+  m_socket->Connect (m_peer);
+  m_socket->SetRecvCallback (MakeCallback (&LoadClient::HandleRead, this));
+
+  if (m_arrival == "onoff")
+    {
+      m_on = false;
+      ToggleOnOff ();
+    }
+  else
+    {
+      SendPacket ();
+    }
+}
+
+void
+LoadClient::StopApplication (void)
+{
+  m_running = false;
+  Simulator::Cancel (m_sendEvent);
+  Simulator::Cancel (m_toggleEvent);
+
+  if (m_socket)
+    {
+      m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket->Close ();
+    }
+}
+
+Time
+LoadClient::NextInterval (void)
+{
+  if (m_arrival == "poisson")
+    {
+      return Seconds (m_interArrival->GetValue ());
+    }
+  if (m_arrival == "onoff")
+    {
+      // Send at the peak rate while on so that the long-run mean is m_packetRate.
+      double peakRate = m_packetRate * (m_onTime + m_offTime) / m_onTime;
+      return Seconds (1.0 / peakRate);
+    }
+  return Seconds (1.0 / m_packetRate);
+}
+
+void
+LoadClient::ScheduleNextTx (void)
+{
+  if (!m_running || (m_arrival == "onoff" && !m_on))
+    {
+      return;
+    }
+
+  Time next = NextInterval ();
+  if (Simulator::Now () + next < m_txStop)
+    {
+      m_sendEvent = Simulator::Schedule (next, &LoadClient::SendPacket, this);
+    }
+}
+
+void
+LoadClient::SendPacket (void)
+{
+  SeqTsHeader seqTs;
+  seqTs.SetSeq (m_sent);
+  Ptr<Packet> packet = Create<Packet> (m_packetSize - seqTs.GetSerializedSize ());
+  packet->AddHeader (seqTs);
+  m_socket->Send (packet);
+  m_sent++;
+
+  ScheduleNextTx ();
+}
+
+void
+LoadClient::ToggleOnOff (void)
+{
+  if (!m_running)
+    {
+      return;
+    }
+
+  m_on = !m_on;
+  if (m_on)
+    {
+      m_toggleEvent = Simulator::Schedule (Seconds (m_onPeriod->GetValue ()),
+                                           &LoadClient::ToggleOnOff, this);
+      if (Simulator::Now () < m_txStop)
+        {
+          SendPacket ();
+        }
+    }
+  else
+    {
+      Simulator::Cancel (m_sendEvent);
+      m_toggleEvent = Simulator::Schedule (Seconds (m_offPeriod->GetValue ()),
+                                           &LoadClient::ToggleOnOff, this);
+    }
+}
+
+void
+LoadClient::HandleRead (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  Address from;
+  while ((packet = socket->RecvFrom (from)))
+    {
+      uint32_t size = packet->GetSize ();
+      SeqTsHeader seqTs;
+      packet->RemoveHeader (seqTs);
+
+      m_latencies.push_back ((Simulator::Now () - seqTs.GetTs ()).GetSeconds ());
+      m_received++;
+      if (Simulator::Now () <= m_txStop)
+        {
+          m_windowRxBytes += size;
+        }
+    }
+}
+
+static double
+Percentile (const std::vector<double> &sorted, double p)
+{
+  if (sorted.empty ())
+    {
+      return 0.0;
+    }
+  std::size_t rank = static_cast<std::size_t> (std::ceil (p / 100.0 * sorted.size ()));
+  return sorted[std::max<std::size_t> (rank, 1) - 1];
+}
+
 int
 main (int argc, char *argv[])
 {
   uint32_t nClients = 1;
   uint32_t nPackets = 1;
+  bool load = false;
+  std::string arrival = "poisson";
+  std::string aggregateRate = "1Mbps";
+  uint32_t packetSize = 1024;
+  double loadDuration = 10.0;
+  double onTime = 0.5;
+  double offTime = 0.5;
+  uint32_t runIndex = 1;
 
   CommandLine cmd;
   cmd.AddValue ("nClients", "Number of client nodes (max 5)", nClients);
   cmd.AddValue ("nPackets", "Number of packets per client (max 5)", nPackets);
+  cmd.AddValue ("load", "Run the open-loop load generator instead of the echo clients", load);
+  cmd.AddValue ("arrival", "Load mode arrival process: poisson, constant or onoff", arrival);
+  cmd.AddValue ("rate", "Load mode aggregate offered rate over all clients", aggregateRate);
+  cmd.AddValue ("packetSize", "Load mode request size in bytes", packetSize);
+  cmd.AddValue ("duration", "Load mode sending time in seconds", loadDuration);
+  cmd.AddValue ("onTime", "Load mode mean on period in seconds (onoff)", onTime);
+  cmd.AddValue ("offTime", "Load mode mean off period in seconds (onoff)", offTime);
+  cmd.AddValue ("run", "Run index for setting repeatable seeds", runIndex);
   cmd.Parse (argc, argv);
 
   nClients = std::max<uint32_t> (1, std::min<uint32_t> (nClients, 5));
   nPackets = std::max<uint32_t> (1, std::min<uint32_t> (nPackets, 5));
 
+  if (arrival != "poisson" && arrival != "constant" && arrival != "onoff")
+    {
+      NS_FATAL_ERROR ("arrival must be poisson, constant or onoff.");
+    }
+
+  if (packetSize < 12 || onTime <= 0 || offTime < 0 || loadDuration <= 0)
+    {
+      NS_FATAL_ERROR ("packetSize must be at least 12 bytes and duration/onTime must be positive.");
+    }
+
+  SeedManager::SetRun (runIndex);
+
   Time::SetResolution (Time::NS);
-  LogComponentEnable ("UdpEchoClientApplication", LOG_LEVEL_INFO);
-  LogComponentEnable ("UdpEchoServerApplication", LOG_LEVEL_INFO);
+  if (!load)
+    {
+      LogComponentEnable ("UdpEchoClientApplication", LOG_LEVEL_INFO);
+      LogComponentEnable ("UdpEchoServerApplication", LOG_LEVEL_INFO);
+    }
+
+  double stopTime = load ? LOAD_START_TIME + loadDuration + LOAD_DRAIN_TIME : 20.0;
+  double clientPacketRate = DataRate (aggregateRate).GetBitRate () / (packetSize * 8.0) / nClients;
+  std::vector<Ptr<LoadClient> > loadClients;
 
   NodeContainer nodes;
   nodes.Create (nClients + 1);
@@ -53,7 +354,7 @@ main (int argc, char *argv[])
   UdpEchoServerHelper echoServer (port);
   ApplicationContainer serverApps = echoServer.Install (server);
   serverApps.Start (Seconds (1.0));
-  serverApps.Stop (Seconds (20.0));
+  serverApps.Stop (Seconds (stopTime));
 
   Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
   rand->SetAttribute ("Min", DoubleValue (0.0));
@@ -73,6 +374,21 @@ main (int argc, char *argv[])
       address.SetBase (base.str ().c_str (), "255.255.255.0");
       Ipv4InterfaceContainer interfaces = address.Assign (devices);
 
+      if (load)
+        {
+          Ptr<LoadClient> loadClient = CreateObject<LoadClient> ();
+          loadClient->Setup (InetSocketAddress (serverAddress, port), packetSize,
+                             clientPacketRate, arrival, onTime, offTime,
+                             Seconds (LOAD_START_TIME + loadDuration));
+          nodes.Get (i)->AddApplication (loadClient);
+          loadClients.push_back (loadClient);
+
+          // Spread the first requests over one mean interval to avoid lock-step clients.
+          loadClient->SetStartTime (Seconds (LOAD_START_TIME + rand->GetValue () / clientPacketRate));
+          loadClient->SetStopTime (Seconds (stopTime));
+          continue;
+        }
+
       UdpEchoClientHelper echoClient (serverAddress, port);
       echoClient.SetAttribute ("MaxPackets", UintegerValue (nPackets));
       echoClient.SetAttribute ("Interval", TimeValue (Seconds (1.0)));
@@ -87,8 +403,47 @@ main (int argc, char *argv[])
 
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
-  Simulator::Stop (Seconds (20.0));
+  Simulator::Stop (Seconds (stopTime));
   Simulator::Run ();
+
+  if (load)
+    {
+      uint64_t sent = 0;
+      uint64_t received = 0;
+      uint64_t windowRxBytes = 0;
+      std::vector<double> latencies;
+      for (auto const &client : loadClients)
+        {
+          sent += client->GetSent ();
+          received += client->GetReceived ();
+          windowRxBytes += client->GetWindowRxBytes ();
+          latencies.insert (latencies.end (), client->GetLatencies ().begin (),
+                            client->GetLatencies ().end ());
+        }
+      // Requests never echoed count at the drain time, the longest latency a
+      // request sent at the end of the window could still have had measured,
+      // so drops push the tail up instead of silently leaving the sample set.
+      latencies.insert (latencies.end (), sent - received, LOAD_DRAIN_TIME);
+      std::sort (latencies.begin (), latencies.end ());
+
+      double offered = DataRate (aggregateRate).GetBitRate () / 1000000.0;
+      double throughput = (double)windowRxBytes * 8 / loadDuration / 1000000.0;
+      double lossRate = sent > 0 ? 1.0 - (double)received / sent : 0.0;
+
+      std::cout << " Load Results \n";
+      std::cout << "Arrival: " << arrival << "\n";
+      std::cout << "NClients: " << nClients << "\n";
+      std::cout << "Offered Load: " << offered << " Mbps\n";
+      std::cout << "Throughput: " << throughput << " Mbps\n";
+      std::cout << "Requests Sent: " << sent << "\n";
+      std::cout << "Requests Completed: " << received << "\n";
+      std::cout << "Loss Rate: " << lossRate << "\n";
+      std::cout << "Latency p50: " << Percentile (latencies, 50) * 1000 << " ms\n";
+      std::cout << "Latency p90: " << Percentile (latencies, 90) * 1000 << " ms\n";
+      std::cout << "Latency p99: " << Percentile (latencies, 99) * 1000 << " ms\n";
+      std::cout << "Latency max: " << Percentile (latencies, 100) * 1000 << " ms\n";
+    }
+
   Simulator::Destroy ();
   return 0;
 }
\ No newline at end of file
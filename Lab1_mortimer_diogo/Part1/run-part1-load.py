@@ -0,0 +1,134 @@
+import subprocess
+import csv
+import re
+import time
+import os
+import sys
+
+OFFERED_LOADS_MBPS = [1, 2, 4, 8, 12, 16, 20, 22, 24, 26, 28, 30]
+ARRIVALS = ["poisson", "constant", "onoff"]
+N_CLIENTS = 5
+PACKET_SIZE = 1024
+DURATION = 10.0
+SIM_NAME = "lab1-part1"
+OUTPUT_FILE = "part1_load_results.csv"
+
+# A load point is past the knee once the server stops keeping up with the
+# load actually sent or the tail latency blows up relative to the lightest
+# load. The realized load is used rather than the nominal rate because
+# Poisson and on/off arrivals send noticeably more or less than nominal over
+# a finite window. Lost requests also mark the knee; the simulator counts
+# them at the drain time in the latency percentiles as well.
+THROUGHPUT_RATIO_KNEE = 0.95
+P99_RATIO_KNEE = 10.0
+LOSS_RATE_KNEE = 0.01
+
+SIM_EXECUTABLE = "./ns3 run " + SIM_NAME + " --"
+subprocess.run(SIM_EXECUTABLE.split()[:-1], check=True, capture_output=True)
+
+PATTERNS = {
+    "throughput": r"Throughput:\s*([\d.e+-]+)\s*Mbps",
+    "sent": r"Requests Sent:\s*(\d+)",
+    "loss": r"Loss Rate:\s*([\d.e+-]+)",
+    "p50": r"Latency p50:\s*([\d.e+-]+)\s*ms",
+    "p90": r"Latency p90:\s*([\d.e+-]+)\s*ms",
+    "p99": r"Latency p99:\s*([\d.e+-]+)\s*ms",
+    "max": r"Latency max:\s*([\d.e+-]+)\s*ms",
+}
+
+
+def run_simulation(offered_mbps, arrival):
+    """
+    Executes the ns-3 script in load mode and parses throughput and latency percentiles.
+    """
+    args = [
+        "--load=true",
+        f"--nClients={N_CLIENTS}",
+        f"--arrival={arrival}",
+        f"--rate={offered_mbps}Mbps",
+        f"--packetSize={PACKET_SIZE}",
+        f"--duration={DURATION}",
+    ]
+
+    cmd = SIM_EXECUTABLE.split() + args
+
+    print(f"-> Running: {arrival}, Offered Load: {offered_mbps} Mbps", flush=True)
+
+    result = subprocess.run(
+        cmd,
+        capture_output=True,
+        text=True,
+        check=True,
+    )
+    output = result.stdout
+
+    values = {}
+    for key, pattern in PATTERNS.items():
+        match = re.search(pattern, output)
+        if not match:
+            print(f"   -> WARNING: Could not find '{key}' in output. Check ns-3 logs.")
+            return None
+        values[key] = float(match.group(1))
+
+    values["realized"] = values["sent"] * PACKET_SIZE * 8 / DURATION / 1000000.0
+
+    print(f"   -> Sent: {values['realized']:.4f} Mbps, Throughput: {values['throughput']:.4f} Mbps, "
+          f"Loss: {values['loss']:.4f}, p99: {values['p99']:.3f} ms")
+    return values
+
+
+def find_knee(rows):
+    """Returns the first offered load (Mbps) past the saturation knee, or None."""
+    if not rows:
+        return None
+    base_p99 = rows[0][1]["p99"]
+    for offered, values in rows:
+        if values["throughput"] < THROUGHPUT_RATIO_KNEE * values["realized"]:
+            return offered
+        if values["loss"] > LOSS_RATE_KNEE:
+            return offered
+        if base_p99 > 0 and values["p99"] > P99_RATIO_KNEE * base_p99:
+            return offered
+    return None
+
+
+def main():
+    """Main function to sweep offered load for every arrival process."""
+
+    print("="*60)
+    print(f"Starting Part 1 load sweep. Total runs: {len(ARRIVALS) * len(OFFERED_LOADS_MBPS)}")
+    print(f"Clients: {N_CLIENTS}, request size: {PACKET_SIZE} bytes, {DURATION}s per point.")
+    print("="*60)
+
+    results = [["Arrival", "Offered Load (Mbps)", "Realized Load (Mbps)", "Throughput (Mbps)", "Loss Rate",
+                "Latency p50 (ms)", "Latency p90 (ms)", "Latency p99 (ms)", "Latency max (ms)"]]
+
+    start_time = time.time()
+
+    for arrival in ARRIVALS:
+        rows = []
+        for offered in OFFERED_LOADS_MBPS:
+            values = run_simulation(offered, arrival)
+            if values is None:
+                continue
+            rows.append((offered, values))
+            results.append([arrival, offered, values["realized"], values["throughput"], values["loss"],
+                            values["p50"], values["p90"], values["p99"], values["max"]])
+
+        knee = find_knee(rows)
+        if knee is None:
+            print(f"   {arrival}: no saturation within the swept range.")
+        else:
+            print(f"   {arrival}: saturation knee at ~{knee} Mbps offered load.")
+
+    end_time = time.time()
+
+    with open(OUTPUT_FILE, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerows(results)
+
+    print(f"SIMULATION COMPLETE. Total time: {end_time - start_time:.2f} seconds.")
+    print(f"Results saved to {OUTPUT_FILE}")
+
+if __name__ == "__main__":
+    main()
@@ -13,6 +13,11 @@ ERROR_RATE = 0.00001
 SIM_NAME = "lab2-part1"
 OUTPUT_FILE = "part1b_results.csv"
 
+if not os.path.exists("scratch/lab2-common.h"):
+    print("FATAL ERROR: scratch/lab2-common.h not found. Run Lab2_mortimer_diogo/install-scratch.sh "
+          "<ns-3 root> first.")
+    sys.exit(1)
+
 try:
     SIM_EXECUTABLE = "./ns3 run " + SIM_NAME + " --"
     subprocess.run(SIM_EXECUTABLE.split()[:-1], check=True, capture_output=True) 
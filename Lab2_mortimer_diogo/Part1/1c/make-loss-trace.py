@@ -0,0 +1,62 @@
+import argparse
+import random
+
+# Writes a loss schedule for --lossModel=trace: the 0-based indices of the
+# bottleneck packets to drop, one per line. Replaying the same file for CUBIC
+# and NewReno gives both protocols identical losses (common random numbers).
+# The "packets=" token in the header comment is required: the simulation
+# refuses to run past the number of packets the trace covers.
+
+# Bytes seen by the bottleneck error model for a full data segment:
+# 536 payload + 32 TCP (with timestamps) + 20 IPv4 + 2 PPP.
+PACKET_BYTES = 590
+
+
+def bernoulli_losses(n_packets, byte_error_rate, packet_bytes, rng):
+    """Independent losses matching RateErrorModel's per-byte ErrorRate."""
+    p_loss = 1.0 - (1.0 - byte_error_rate) ** packet_bytes
+    return [i for i in range(n_packets) if rng.random() < p_loss]
+
+
+def gilbert_losses(n_packets, p_good_to_bad, p_bad_to_good, loss_good, loss_bad, rng):
+    """Bursty losses from a two-state Gilbert-Elliott chain."""
+    losses = []
+    bad = False
+    for i in range(n_packets):
+        transition = rng.random()
+        bad = transition >= p_bad_to_good if bad else transition < p_good_to_bad
+        if rng.random() < (loss_bad if bad else loss_good):
+            losses.append(i)
+    return losses
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a packet-index loss trace.")
+    parser.add_argument("output", help="Trace file to write")
+    parser.add_argument("--model", choices=["rate", "gilbert"], default="rate")
+    parser.add_argument("--packets", type=int, default=100000, help="Number of packet indices to cover")
+    parser.add_argument("--errorRate", type=float, default=0.00001, help="Byte error rate (model=rate)")
+    parser.add_argument("--packetBytes", type=int, default=PACKET_BYTES)
+    parser.add_argument("--goodToBad", type=float, default=0.001)
+    parser.add_argument("--badToGood", type=float, default=0.1)
+    parser.add_argument("--lossGood", type=float, default=0.0)
+    parser.add_argument("--lossBad", type=float, default=0.5)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    if args.model == "rate":
+        losses = bernoulli_losses(args.packets, args.errorRate, args.packetBytes, rng)
+    else:
+        losses = gilbert_losses(args.packets, args.goodToBad, args.badToGood,
+                                args.lossGood, args.lossBad, rng)
+
+    with open(args.output, 'w') as f:
+        f.write(f"# model={args.model} packets={args.packets} seed={args.seed}\n")
+        for index in losses:
+            f.write(f"{index}\n")
+
+    print(f"Wrote {len(losses)} losses over {args.packets} packets to {args.output}")
+
+if __name__ == "__main__":
+    main()
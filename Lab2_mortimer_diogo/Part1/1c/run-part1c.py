@@ -1,3 +1,4 @@
+import argparse
 import subprocess
 import csv
 import re
@@ -13,10 +14,36 @@ DELAY_MS = 1
 SIM_NAME = "lab2-part1" 
 OUTPUT_FILE = "part1c_results.csv"
 
+# "rate" (default) keeps the per-packet RateErrorModel draws behind the
+# committed part1c_results.csv. "trace" replays one precomputed loss schedule
+# per error rate, so CUBIC and NewReno see identical losses and the comparison
+# needs fewer repetitions; select it with --lossModel=trace.
+LOSS_MODEL = "rate"
+TRACE_GENERATOR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "make-loss-trace.py")
+
+if not os.path.exists("scratch/lab2-common.h"):
+    print("FATAL ERROR: scratch/lab2-common.h not found. Run Lab2_mortimer_diogo/install-scratch.sh "
+          "<ns-3 root> first.")
+    sys.exit(1)
+
 SIM_EXECUTABLE = "./ns3 run " + SIM_NAME + " --"
 subprocess.run(SIM_EXECUTABLE.split()[:-1], check=True, capture_output=True) 
 
 
+def trace_file_name(error_rate):
+    return f"loss-trace-{error_rate}.txt"
+
+
+def make_loss_traces():
+    """Generates one packet-index loss trace per error rate."""
+    for error_rate in ERROR_RATES:
+        subprocess.run(
+            [sys.executable, TRACE_GENERATOR, trace_file_name(error_rate),
+             "--model=rate", f"--errorRate={error_rate}"],
+            check=True,
+        )
+
+
 def run_simulation(n_flows, error_rate, protocol):
     """
     Executes the ns-3 script and captures the Total Aggregate Goodput.
@@ -28,8 +55,12 @@ def run_simulation(n_flows, error_rate, protocol):
         f"--transport_prot={protocol}",
         f"--dataRate={DATA_RATE}",
         f"--delay={delay_str}",
-        f"--errorRate={error_rate}"
+        f"--lossModel={LOSS_MODEL}"
     ]
+    if LOSS_MODEL == "trace":
+        args.append(f"--lossTrace={trace_file_name(error_rate)}")
+    else:
+        args.append(f"--errorRate={error_rate}")
     
     cmd = SIM_EXECUTABLE.split() + args
     
@@ -56,13 +87,22 @@ def run_simulation(n_flows, error_rate, protocol):
 
 def main():
     """Main function to loop through all scenarios and collect data."""
+    global LOSS_MODEL
+
+    parser = argparse.ArgumentParser(description="Part 1c error-rate sweep.")
+    parser.add_argument("--lossModel", choices=["rate", "trace"], default=LOSS_MODEL,
+                        help="Bottleneck loss model passed to lab2-part1")
+    LOSS_MODEL = parser.parse_args().lossModel
     
     total_runs = len(FLOW_COUNTS) * len(ERROR_RATES) * len(PROTOCOLS)
     print(f"Starting Part 1c simulations. Total runs: {total_runs}")
-    print(f"Bottleneck: {DATA_RATE}, {DELAY_MS}ms delay.")
+    print(f"Bottleneck: {DATA_RATE}, {DELAY_MS}ms delay, loss model: {LOSS_MODEL}.")
     
     results = [["Protocol", "NFlows", "Error Rate", "Aggregate Goodput (Mbps)"]]
     
+    if LOSS_MODEL == "trace":
+        make_loss_traces()
+
     start_time = time.time()
     
     for protocol in PROTOCOLS:
@@ -37,6 +37,8 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <algorithm>
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
@@ -53,6 +55,8 @@
 #include "ns3/traffic-control-module.h"
 #include "ns3/ipv4-flow-classifier.h"
 
+#include "../lab2-common.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("TcpBottleneckComparison");
@@ -126,9 +130,17 @@ int main (int argc, char *argv[])
   std::string transport_prot = "TcpCubic";
   std::string bottleneck_data_rate = "1Mbps";
   std::string bottleneck_delay = "20ms";
-  double errorRate = 0.00001;
+  double errorRate = DEFAULT_ERROR_RATE;
   uint32_t nFlows = 1;
   uint64_t data_mbytes = 0;
+  std::string lossModel = "rate";
+  double geGoodToBad = 0.001;
+  double geBadToGood = 0.1;
+  double geLossGood = 0.0;
+  double geLossBad = 0.5;
+  std::string lossTrace = "";
+  std::string accounting = "flowmon";
+  bool probeStats = false;
 
   CommandLine cmd (__FILE__);
   cmd.AddValue ("transport_prot", "Transport protocol to use: TcpCubic or TcpNewReno", transport_prot);
@@ -136,6 +148,15 @@ int main (int argc, char *argv[])
   cmd.AddValue ("delay", "Bottleneck link delay (e.g., 20ms)", bottleneck_delay);
   cmd.AddValue ("errorRate", "Bottleneck link byte error rate (e.g., 0.00001)", errorRate);
   cmd.AddValue ("nFlows", "Number of concurrent TCP flows (max 20)", nFlows);
+  cmd.AddValue ("lossModel", "Bottleneck loss model: rate, gilbert or trace", lossModel);
+  cmd.AddValue ("geGoodToBad", "Gilbert-Elliott per-packet good to bad transition probability", geGoodToBad);
+  cmd.AddValue ("geBadToGood", "Gilbert-Elliott per-packet bad to good transition probability", geBadToGood);
+  cmd.AddValue ("geLossGood", "Gilbert-Elliott loss probability in the good state", geLossGood);
+  cmd.AddValue ("geLossBad", "Gilbert-Elliott loss probability in the bad state", geLossBad);
+  cmd.AddValue ("lossTrace", "Loss trace file with the packet indices to drop (lossModel=trace)", lossTrace);
+  cmd.AddValue ("accounting", "Flow accounting: probe (sink/source counters) or flowmon (FlowMonitor on every node)", accounting);
+  cmd.AddValue ("probeStats", "Collect per-flow ACK RTT, retransmission and delivery statistics with the probe", probeStats);
+  cmd.AddValue ("telemetry", "Publish periodic telemetry to this file, or unix:<path> for a Unix datagram socket", telemetryTarget);
   cmd.Parse (argc, argv);
 
   if (nFlows == 0 || nFlows > 20)
@@ -148,6 +169,32 @@ int main (int argc, char *argv[])
       NS_FATAL_ERROR ("transport_prot must be either TcpCubic or TcpNewReno.");
     }
 
+  if (lossModel != "rate" && lossModel != "gilbert" && lossModel != "trace")
+    {
+      NS_FATAL_ERROR ("lossModel must be rate, gilbert or trace.");
+    }
+
+  if (lossModel == "trace" && lossTrace.empty ())
+    {
+      NS_FATAL_ERROR ("lossModel=trace requires a lossTrace file.");
+    }
+
+  if (lossModel != "rate" && errorRate != DEFAULT_ERROR_RATE)
+    {
+      NS_FATAL_ERROR ("errorRate only applies to lossModel=rate; use the ge* parameters or the trace instead.");
+    }
+
+  if (geGoodToBad < 0 || geGoodToBad > 1 || geBadToGood < 0 || geBadToGood > 1
+      || geLossGood < 0 || geLossGood > 1 || geLossBad < 0 || geLossBad > 1)
+    {
+      NS_FATAL_ERROR ("geGoodToBad, geBadToGood, geLossGood and geLossBad must be in [0, 1].");
+    }
+
+  if (accounting != "probe" && accounting != "flowmon")
+    {
+      NS_FATAL_ERROR ("accounting must be either probe or flowmon.");
+    }
+
   std::string full_transport_prot = std::string ("ns3::") + transport_prot;
   
   SeedManager::SetSeed (1);
@@ -175,14 +222,30 @@ int main (int argc, char *argv[])
   bottleneckLink.SetDeviceAttribute ("DataRate", StringValue (bottleneck_data_rate));
   bottleneckLink.SetChannelAttribute ("Delay", StringValue (bottleneck_delay));
 
-  Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
-  em->SetAttribute ("ErrorRate", DoubleValue (errorRate));
-  bottleneckLink.SetDeviceAttribute ("ReceiveErrorModel", PointerValue (em));
+  if (lossModel == "rate")
+    {
+      Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
+      em->SetAttribute ("ErrorRate", DoubleValue (errorRate));
+      bottleneckLink.SetDeviceAttribute ("ReceiveErrorModel", PointerValue (em));
+    }
 
   NetDeviceContainer d1d2 = highSpeedLink.Install (n1, n2);
 
   NetDeviceContainer d2d3 = bottleneckLink.Install (n2, n3);
 
+  if (lossModel == "gilbert")
+    {
+      Ptr<GilbertElliottErrorModel> ge = CreateObject<GilbertElliottErrorModel> ();
+      ge->Setup (geGoodToBad, geBadToGood, geLossGood, geLossBad, LOSS_MODEL_STREAM);
+      d2d3.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (ge));
+    }
+  else if (lossModel == "trace")
+    {
+      Ptr<TraceErrorModel> trace = CreateObject<TraceErrorModel> ();
+      trace->LoadTrace (lossTrace);
+      d2d3.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (trace));
+    }
+
   NetDeviceContainer d3d4 = highSpeedLink.Install (n3, n4);
   
   InternetStackHelper stack;
@@ -240,36 +303,85 @@ int main (int argc, char *argv[])
       std::string cwndFileName = "cwnd-trace-" + flowIdStr.str() + ".csv";
       
       Simulator::Schedule (Seconds (traceStartTime), &TraceCwnd, cwndFileName, 0, i);
+
+      if (accounting == "probe" && probeStats)
+        {
+          Simulator::Schedule (Seconds (traceStartTime), &TraceProbeSocket, n1->GetId (), i, i);
+        }
     }
 
 
   Ptr<FlowMonitor> flowMonitor;
   FlowMonitorHelper flowHelper;
-  flowMonitor = flowHelper.InstallAll ();
+  if (accounting == "flowmon")
+    {
+      flowMonitor = flowHelper.InstallAll ();
+    }
+  else
+    {
+      InstallFlowProbe (sinkApps, sourceApps, nFlows);
+    }
+
+  if (!telemetryTarget.empty ())
+    {
+      StartTelemetry (sinkApps, NetDeviceContainer (d2d3.Get (0)));
+    }
 
   NS_LOG_INFO ("Running simulation for " << SIMULATION_DURATION << " seconds.");
   Simulator::Stop (Seconds (SIMULATION_DURATION));
   Simulator::Run ();
 
+  if (!telemetryTarget.empty ())
+    {
+      StopTelemetry (sinkApps, NetDeviceContainer (d2d3.Get (0)));
+    }
+
   std::cout << "\n======================================================\n";
-  std::cout << "Flow Monitor Results (" << transport_prot << ") - Goodput\n";
+  if (accounting == "flowmon")
+    {
+      std::cout << "Flow Monitor Results (" << transport_prot << ") - Goodput\n";
+    }
+  else
+    {
+      std::cout << "Flow Probe Results (" << transport_prot << ") - Goodput\n";
+    }
   std::cout << "======================================================\n";
 
-  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
-  std::map<FlowId, FlowMonitor::FlowStats> stats = flowMonitor->GetFlowStats ();
-
   double totalGoodput = 0.0;
-  
-  for (auto const& iter : stats)
-    {
-      Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (iter.first);
-      
-      double goodput = (double)iter.second.rxBytes * 8 / (SIMULATION_DURATION - FLOW_START_TIME) / 1000000.0;
-      totalGoodput += goodput;
 
-      std::cout << "Flow ID " << iter.first << " (" << t.sourceAddress << " -> " << t.destinationAddress 
-                << ", Port " << t.destinationPort << "): "
-                << goodput << " Mbps (Goodput)\n";
+  if (accounting == "flowmon")
+    {
+      Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
+      std::map<FlowId, FlowMonitor::FlowStats> stats = flowMonitor->GetFlowStats ();
+
+      for (auto const& iter : stats)
+        {
+          Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (iter.first);
+          
+          double goodput = (double)iter.second.rxBytes * 8 / (SIMULATION_DURATION - FLOW_START_TIME) / 1000000.0;
+          totalGoodput += goodput;
+
+          std::cout << "Flow ID " << iter.first << " (" << t.sourceAddress << " -> " << t.destinationAddress 
+                    << ", Port " << t.destinationPort << "): "
+                    << goodput << " Mbps (Goodput)\n";
+        }
+    }
+  else
+    {
+      for (uint32_t i = 0; i < nFlows; ++i)
+        {
+          double goodput = (double)flowProbe.rxBytes[i] * 8 / (SIMULATION_DURATION - FLOW_START_TIME) / 1000000.0;
+          totalGoodput += goodput;
+
+          std::cout << "Flow ID " << i + 1 << " (-> " << sinkIpAddress << ", Port " << port + i << "): "
+                    << goodput << " Mbps (Goodput)";
+          if (probeStats)
+            {
+              std::cout << ", ";
+              PrintProbeStats (i);
+            }
+          std::cout << "\n";
+        }
     }
 
   std::cout << "\nTotal Aggregate Goodput: " << totalGoodput << " Mbps\n";
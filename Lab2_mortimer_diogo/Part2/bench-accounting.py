@@ -0,0 +1,134 @@
+import subprocess
+import csv
+import os
+import re
+import sys
+import time
+
+# Compares the flow probe against FlowMonitor on lab2-part2 as the flow count
+# grows. The built simulation binary is run directly (not through the ./ns3
+# wrapper) so wall time and peak RSS belong to the simulation alone. The
+# bottleneck rate grows with the flow count so the number of packets does too,
+# and a --setupOnly run of the same scenario (topology, applications and
+# accounting built, nothing simulated) is subtracted, leaving the cost of the
+# simulated packets. Overhead is reported per delivered TCP segment.
+#
+# Timings are only meaningful for an optimized build:
+#   ./ns3 configure -d optimized && python3 bench-accounting.py
+
+FLOW_COUNTS = [2, 8, 32, 64, 128, 200]
+ACCOUNTING = ["probe", "flowmon"]
+NUM_RUNS = 3
+# 200 flows reach 100Mbps, the rate of the access links.
+PER_FLOW_RATE_MBPS = 0.5
+SEGMENT_SIZE = 536
+SIM_NAME = "lab2-part2"
+OUTPUT_FILE = "accounting_benchmark.csv"
+
+if not os.path.exists("scratch/lab2-common.h"):
+    print("FATAL ERROR: scratch/lab2-common.h not found. Run Lab2_mortimer_diogo/install-scratch.sh "
+          "<ns-3 root> first.")
+    sys.exit(1)
+
+subprocess.run(["./ns3", "build", SIM_NAME], check=True, capture_output=True)
+
+
+def find_sim_binary():
+    """
+    Locates the compiled lab2-part2 binary under build/scratch. ns-3 appends the
+    build profile to the name (none for release), so debug and default builds
+    are refused.
+    """
+    found = []
+    for root, _, files in os.walk("build/scratch"):
+        for name in files:
+            path = os.path.join(root, name)
+            if name.startswith("ns3") and f"-{SIM_NAME}" in name and os.access(path, os.X_OK):
+                if name.endswith(f"-{SIM_NAME}") or name.endswith(f"-{SIM_NAME}-optimized"):
+                    return path
+                found.append(name)
+    if found:
+        print(f"FATAL ERROR: Only non-optimized builds found ({', '.join(found)}). "
+              "Run './ns3 configure -d optimized' first.")
+    else:
+        print("FATAL ERROR: Could not locate the compiled lab2-part2 binary under build/scratch.")
+    sys.exit(1)
+
+
+SIM_BINARY = find_sim_binary()
+
+
+def run_single_benchmark(n_flows, accounting, setup_only=False):
+    """
+    Runs one simulation and returns (wall seconds, peak RSS in MB, delivered segments).
+    """
+    half = n_flows // 2
+    cmd = [
+        SIM_BINARY,
+        f"--groups=0.01ms:{half}:TcpCubic,50ms:{n_flows - half}:TcpCubic",
+        f"--dataRate={n_flows * PER_FLOW_RATE_MBPS}Mbps",
+        f"--accounting={accounting}",
+    ]
+    if setup_only:
+        cmd.append("--setupOnly=true")
+
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    output = proc.stdout.read()
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+
+    if status != 0:
+        print(f"   -> WARNING: {accounting} with {n_flows} flows exited with status {status}.")
+
+    match = re.search(r"Delivered Bytes:\s*(\d+)", output)
+    segments = int(match.group(1)) / SEGMENT_SIZE if match else 0.0
+
+    # ru_maxrss is reported in kilobytes on Linux.
+    return wall, usage.ru_maxrss / 1024.0, segments
+
+
+def main():
+    """Main function to benchmark both accounting modes over all flow counts."""
+
+    print("="*60)
+    print(f"Starting accounting benchmark. Runs per point: {NUM_RUNS}")
+    print("="*60)
+
+    results = [["Accounting", "NFlows", "Bottleneck Rate (Mbps)", "Wall Time (s)", "Setup Wall Time (s)",
+                "Peak RSS (MB)", "Setup Peak RSS (MB)", "Delivered Segments", "Wall Time per Segment (us)"]]
+
+    for n_flows in FLOW_COUNTS:
+        for accounting in ACCOUNTING:
+            walls = []
+            rss = []
+            setup_walls = []
+            setup_rss = []
+            segments = 0.0
+            for _ in range(NUM_RUNS):
+                wall, peak, segments = run_single_benchmark(n_flows, accounting)
+                walls.append(wall)
+                rss.append(peak)
+                wall, peak, _ = run_single_benchmark(n_flows, accounting, setup_only=True)
+                setup_walls.append(wall)
+                setup_rss.append(peak)
+
+            best_wall = min(walls)
+            best_setup = min(setup_walls)
+            max_rss = max(rss)
+            max_setup_rss = max(setup_rss)
+            run_wall = max(best_wall - best_setup, 0.0)
+            per_segment_us = run_wall / segments * 1e6 if segments > 0 else 0.0
+            print(f"  {accounting:8s} {n_flows:4d} flows: {best_wall:8.2f} s ({best_setup:6.2f} s setup), "
+                  f"{max_rss:8.1f} MB ({max_setup_rss:6.1f} MB setup), {per_segment_us:8.3f} us/segment")
+            results.append([accounting, n_flows, n_flows * PER_FLOW_RATE_MBPS, best_wall, best_setup,
+                            max_rss, max_setup_rss, segments, per_segment_us])
+
+    with open(OUTPUT_FILE, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerows(results)
+
+    print(f"Results saved to {OUTPUT_FILE}")
+
+if __name__ == "__main__":
+    main()
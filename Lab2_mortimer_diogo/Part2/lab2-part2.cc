@@ -2,7 +2,9 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <algorithm>
 #include <map>
+#include <vector>
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
@@ -19,6 +21,8 @@
 #include "ns3/traffic-control-module.h"
 #include "ns3/ipv4-flow-classifier.h"
 
+#include "../lab2-common.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("TcpRttFairnessComparison");
@@ -28,29 +32,16 @@ const double FLOW_START_TIME = 1.0;
 const double SINK_START_TIME = 0.0;
 const std::string COMMON_DATA_RATE = "100Mbps";
 const std::string COMMON_DELAY = "0.01ms";
-const std::string LONG_DELAY = "50ms"; 
+const std::string LONG_DELAY = "50ms";
+const uint32_t MAX_FLOWS = 200;
 
 static std::map<uint32_t, bool> firstCwnd;
 static std::map<uint32_t, Ptr<OutputStreamWrapper>> cWndStream;
 static std::map<uint32_t, uint32_t> cWndValue;
 
-static uint32_t
-GetSocketIndexFromContext (std::string context)
-{
-  std::size_t const n1 = context.find ("/SocketList/");
-  if (n1 == std::string::npos)
-    {
-      return 0;
-    }
-  std::size_t const n2 = context.find_first_of ("/", n1 + 12);
-  return std::stoul (context.substr (n1 + 12, n2 - n1 - 12));
-}
-
 static void
-CwndTracer (std::string context, uint32_t oldval, uint32_t newval)
+CwndTracer (uint32_t flowId, uint32_t oldval, uint32_t newval)
 {
-  uint32_t flowId = GetSocketIndexFromContext (context);
-
   if (firstCwnd.find(flowId) == firstCwnd.end()) 
     {
       firstCwnd[flowId] = true;
@@ -67,16 +58,102 @@ CwndTracer (std::string context, uint32_t oldval, uint32_t newval)
 }
 
 static void
-TraceCwnd (std::string cwnd_tr_file_name, uint32_t nodeId, uint32_t socketIndex)
+TraceCwnd (std::string cwnd_tr_file_name, uint32_t nodeId, uint32_t socketIndex, uint32_t flowId)
 {
   AsciiTraceHelper ascii;
-  cWndStream[socketIndex] = ascii.CreateFileStream (cwnd_tr_file_name.c_str ());
+  cWndStream[flowId] = ascii.CreateFileStream (cwnd_tr_file_name.c_str ());
   
   std::stringstream path;
   path << "/NodeList/" << nodeId << "/$ns3::TcpL4Protocol/SocketList/" 
        << socketIndex << "/CongestionWindow";
        
-  Config::Connect (path.str (), MakeCallback (&CwndTracer));
+  Config::ConnectWithoutContext (path.str (), MakeBoundCallback (&CwndTracer, flowId));
+}
+
+// One RTT group: nFlows flows of the same protocol that share an access delay
+// to their sink and traverse the bottleneck chain from entryHop to exitHop.
+struct RttGroup
+{
+  std::string delay;
+  uint32_t nFlows;
+  std::string protocol;
+  uint32_t entryHop;
+  uint32_t exitHop;
+};
+
+static std::vector<std::string>
+SplitString (std::string str, char delim)
+{
+  std::vector<std::string> tokens;
+  std::stringstream ss (str);
+  std::string token;
+  while (std::getline (ss, token, delim))
+    {
+      tokens.push_back (token);
+    }
+  return tokens;
+}
+
+static uint32_t
+ParseGroupField (std::string field, std::string name, std::string groupSpec)
+{
+  if (field.empty () || field.size () > 9 || field.find_first_not_of ("0123456789") != std::string::npos)
+    {
+      NS_FATAL_ERROR ("Invalid " << name << " '" << field << "' in RTT group '" << groupSpec << "'.");
+    }
+  return std::stoul (field);
+}
+
+// Parses "delay:nFlows:protocol[:entryHop:exitHop],..." into RTT groups.
+static std::vector<RttGroup>
+ParseRttGroups (std::string spec, uint32_t nBottlenecks)
+{
+  std::vector<RttGroup> groups;
+  for (std::string const& groupSpec : SplitString (spec, ','))
+    {
+      std::vector<std::string> fields = SplitString (groupSpec, ':');
+      if (fields.size () != 3 && fields.size () != 5)
+        {
+          NS_FATAL_ERROR ("Invalid RTT group '" << groupSpec << "', expected delay:nFlows:protocol[:entryHop:exitHop].");
+        }
+
+      RttGroup group;
+      group.delay = fields[0];
+      group.nFlows = ParseGroupField (fields[1], "nFlows", groupSpec);
+      group.protocol = fields[2];
+      group.entryHop = fields.size () == 5 ? ParseGroupField (fields[3], "entryHop", groupSpec) : 0;
+      group.exitHop = fields.size () == 5 ? ParseGroupField (fields[4], "exitHop", groupSpec) : nBottlenecks;
+
+      TypeId tid;
+      if (!TypeId::LookupByNameFailSafe ("ns3::" + group.protocol, &tid)
+          || !tid.IsChildOf (TcpCongestionOps::GetTypeId ()))
+        {
+          NS_FATAL_ERROR ("Unknown TCP congestion control '" << group.protocol << "' in RTT group '" << groupSpec << "'.");
+        }
+      if (group.nFlows == 0)
+        {
+          NS_FATAL_ERROR ("RTT group '" << groupSpec << "' must have at least one flow.");
+        }
+      if (group.entryHop >= group.exitHop || group.exitHop > nBottlenecks)
+        {
+          NS_FATAL_ERROR ("RTT group '" << groupSpec << "' must satisfy entryHop < exitHop <= nBottlenecks.");
+        }
+      groups.push_back (group);
+    }
+  return groups;
+}
+
+static double
+JainFairness (std::vector<double> const& values)
+{
+  double sum = 0.0;
+  double sumSq = 0.0;
+  for (double v : values)
+    {
+      sum += v;
+      sumSq += v * v;
+    }
+  return sumSq > 0.0 ? sum * sum / (values.size () * sumSq) : 0.0;
 }
 
 int main (int argc, char *argv[])
@@ -85,10 +162,21 @@ int main (int argc, char *argv[])
   std::string transport_prot = "TcpCubic";
   std::string bottleneck_data_rate = "1Mbps";
   std::string bottleneck_delay = "20ms";
-  double errorRate = 0.00001;
+  double errorRate = DEFAULT_ERROR_RATE;
   uint32_t nFlows = 2; 
   uint32_t runIndex = 0; 
   uint64_t data_mbytes = 0;
+  std::string lossModel = "rate";
+  double geGoodToBad = 0.001;
+  double geBadToGood = 0.1;
+  double geLossGood = 0.0;
+  double geLossBad = 0.5;
+  std::string lossTrace = "";
+  std::string accounting = "flowmon";
+  bool probeStats = false;
+  bool setupOnly = false;
+  std::string groupSpec = "";
+  uint32_t nBottlenecks = 1;
 
   CommandLine cmd (__FILE__);
   cmd.AddValue ("transport_prot", "Transport protocol: TcpCubic or TcpNewReno", transport_prot);
@@ -97,16 +185,81 @@ int main (int argc, char *argv[])
   cmd.AddValue ("errorRate", "Bottleneck link byte error rate", errorRate);
   cmd.AddValue ("nFlows", "Total number of flows (must be even, max 20)", nFlows);
   cmd.AddValue ("run", "Run index for setting repeatable seeds (0-9)", runIndex); 
+  cmd.AddValue ("groups", "RTT groups as delay:nFlows:protocol[:entryHop:exitHop],... where protocol "
+                "is a TCP congestion control such as TcpCubic (overrides nFlows/transport_prot)", groupSpec);
+  cmd.AddValue ("nBottlenecks", "Number of chained bottleneck links (parking lot)", nBottlenecks);
+  cmd.AddValue ("lossModel", "Bottleneck loss model: rate, gilbert or trace", lossModel);
+  cmd.AddValue ("geGoodToBad", "Gilbert-Elliott per-packet good to bad transition probability", geGoodToBad);
+  cmd.AddValue ("geBadToGood", "Gilbert-Elliott per-packet bad to good transition probability", geBadToGood);
+  cmd.AddValue ("geLossGood", "Gilbert-Elliott loss probability in the good state", geLossGood);
+  cmd.AddValue ("geLossBad", "Gilbert-Elliott loss probability in the bad state", geLossBad);
+  cmd.AddValue ("lossTrace", "Loss trace file with the packet indices to drop (lossModel=trace)", lossTrace);
+  cmd.AddValue ("accounting", "Flow accounting: probe (sink/source counters) or flowmon (FlowMonitor on every node)", accounting);
+  cmd.AddValue ("probeStats", "Collect per-flow ACK RTT, retransmission and delivery statistics with the probe", probeStats);
+  cmd.AddValue ("setupOnly", "Build the scenario and accounting, then exit without running (benchmark baseline)", setupOnly);
+  cmd.AddValue ("telemetry", "Publish periodic telemetry to this file, or unix:<path> for a Unix datagram socket", telemetryTarget);
   cmd.Parse (argc, argv);
 
-  if (nFlows == 0 || nFlows % 2 != 0 || nFlows > 20)
+  if (transport_prot != "TcpCubic" && transport_prot != "TcpNewReno")
     {
-      NS_FATAL_ERROR ("nFlows must be an even number between 2 and 20.");
+      NS_FATAL_ERROR ("transport_prot must be either TcpCubic or TcpNewReno.");
     }
 
-  if (transport_prot != "TcpCubic" && transport_prot != "TcpNewReno")
+  if (lossModel != "rate" && lossModel != "gilbert" && lossModel != "trace")
     {
-      NS_FATAL_ERROR ("transport_prot must be either TcpCubic or TcpNewReno.");
+      NS_FATAL_ERROR ("lossModel must be rate, gilbert or trace.");
+    }
+
+  if (lossModel == "trace" && lossTrace.empty ())
+    {
+      NS_FATAL_ERROR ("lossModel=trace requires a lossTrace file.");
+    }
+
+  if (lossModel != "rate" && errorRate != DEFAULT_ERROR_RATE)
+    {
+      NS_FATAL_ERROR ("errorRate only applies to lossModel=rate; use the ge* parameters or the trace instead.");
+    }
+
+  if (geGoodToBad < 0 || geGoodToBad > 1 || geBadToGood < 0 || geBadToGood > 1
+      || geLossGood < 0 || geLossGood > 1 || geLossBad < 0 || geLossBad > 1)
+    {
+      NS_FATAL_ERROR ("geGoodToBad, geBadToGood, geLossGood and geLossBad must be in [0, 1].");
+    }
+
+  if (accounting != "probe" && accounting != "flowmon")
+    {
+      NS_FATAL_ERROR ("accounting must be either probe or flowmon.");
+    }
+
+  if (nBottlenecks == 0)
+    {
+      NS_FATAL_ERROR ("nBottlenecks must be at least 1.");
+    }
+
+  std::vector<RttGroup> groups;
+  if (groupSpec.empty ())
+    {
+      // Default scenario: half of the flows to a short-RTT sink, half to a long-RTT sink.
+      if (nFlows == 0 || nFlows % 2 != 0 || nFlows > 20)
+        {
+          NS_FATAL_ERROR ("nFlows must be an even number between 2 and 20.");
+        }
+      groups.push_back ({COMMON_DELAY, nFlows / 2, transport_prot, 0, nBottlenecks});
+      groups.push_back ({LONG_DELAY, nFlows / 2, transport_prot, 0, nBottlenecks});
+    }
+  else
+    {
+      groups = ParseRttGroups (groupSpec, nBottlenecks);
+    }
+
+  nFlows = 0;
+  for (RttGroup const& group : groups)
+    {
+      nFlows += group.nFlows;
+    }
+  if (nFlows > MAX_FLOWS)
+    {
+      NS_FATAL_ERROR ("Total number of flows must not exceed " << MAX_FLOWS << ".");
     }
 
   std::string full_transport_prot = std::string ("ns3::") + transport_prot;
@@ -120,98 +273,172 @@ int main (int argc, char *argv[])
   Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (1 << 21));
   Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (1 << 21));
 
-  //  2. Topology Creation (5 Nodes) 
-  NodeContainer nodes;
-  nodes.Create (5); 
-  Ptr<Node> n1 = nodes.Get (0);
-  Ptr<Node> n2 = nodes.Get (1);
-  Ptr<Node> n3 = nodes.Get (2);
-  Ptr<Node> n4 = nodes.Get (3);
-  Ptr<Node> n5 = nodes.Get (4);
+  //  2. Topology Creation
+  //
+  //  src --+                                     +-- sink_g (group delay)
+  //        r0 ==== r1 ==== ... ==== r(nBottlenecks)
+  //
+  //  Groups with the same protocol and entryHop share one source node, so the
+  //  default scenario keeps the original n1 -> n2 ==== n3 -> {n4, n5} layout;
+  //  a separate source is only needed where the socket type or entry point
+  //  differs. Each group has its own sink attached to router exitHop. Nodes,
+  //  links and addresses are created in the same order as the original
+  //  5-node program so its results can be regenerated.
+  std::vector<uint32_t> groupSource;
+  std::vector<uint32_t> sourceGroup;
+  for (uint32_t g = 0; g < groups.size (); ++g)
+    {
+      uint32_t s = 0;
+      while (s < sourceGroup.size ()
+             && (groups[sourceGroup[s]].protocol != groups[g].protocol
+                 || groups[sourceGroup[s]].entryHop != groups[g].entryHop))
+        {
+          ++s;
+        }
+      if (s == sourceGroup.size ())
+        {
+          sourceGroup.push_back (g);
+        }
+      groupSource.push_back (s);
+    }
+
+  if (sourceGroup.size () + nBottlenecks + groups.size () > 255)
+    {
+      NS_FATAL_ERROR ("Too many links for the 10.<k>.<k>.0 addressing plan (max 255).");
+    }
+
+  NodeContainer sources;
+  sources.Create (sourceGroup.size ());
+  NodeContainer routers;
+  routers.Create (nBottlenecks + 1);
+  NodeContainer sinks;
+  sinks.Create (groups.size ());
 
   PointToPointHelper highSpeedLink;
   highSpeedLink.SetDeviceAttribute ("DataRate", StringValue (COMMON_DATA_RATE));
   highSpeedLink.SetChannelAttribute ("Delay", StringValue (COMMON_DELAY)); // 0.01ms
 
-  PointToPointHelper longDelayLink;
-  longDelayLink.SetDeviceAttribute ("DataRate", StringValue (COMMON_DATA_RATE));
-  longDelayLink.SetChannelAttribute ("Delay", StringValue (LONG_DELAY)); // 50ms
-
   PointToPointHelper bottleneckLink;
   bottleneckLink.SetDeviceAttribute ("DataRate", StringValue (bottleneck_data_rate));
   bottleneckLink.SetChannelAttribute ("Delay", StringValue (bottleneck_delay));
 
-  Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
-  em->SetAttribute ("ErrorRate", DoubleValue (errorRate));
-  bottleneckLink.SetDeviceAttribute ("ReceiveErrorModel", PointerValue (em));
+  std::vector<NetDeviceContainer> links;
+
+  for (uint32_t s = 0; s < sourceGroup.size (); ++s)
+    {
+      links.push_back (highSpeedLink.Install (sources.Get (s), routers.Get (groups[sourceGroup[s]].entryHop)));
+    }
+
+  std::vector<NetDeviceContainer> bottleneckDevices;
+  for (uint32_t h = 0; h < nBottlenecks; ++h)
+    {
+      if (lossModel == "rate")
+        {
+          Ptr<RateErrorModel> em = CreateObject<RateErrorModel> ();
+          em->SetAttribute ("ErrorRate", DoubleValue (errorRate));
+          bottleneckLink.SetDeviceAttribute ("ReceiveErrorModel", PointerValue (em));
+        }
+      bottleneckDevices.push_back (bottleneckLink.Install (routers.Get (h), routers.Get (h + 1)));
+      links.push_back (bottleneckDevices[h]);
+
+      // Each hop keeps its own packet index; gilbert hops use distinct streams
+      // and trace hops replay the same schedule.
+      if (lossModel == "gilbert")
+        {
+          Ptr<GilbertElliottErrorModel> ge = CreateObject<GilbertElliottErrorModel> ();
+          ge->Setup (geGoodToBad, geBadToGood, geLossGood, geLossBad, LOSS_MODEL_STREAM + h);
+          bottleneckDevices[h].Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (ge));
+        }
+      else if (lossModel == "trace")
+        {
+          Ptr<TraceErrorModel> trace = CreateObject<TraceErrorModel> ();
+          trace->LoadTrace (lossTrace);
+          bottleneckDevices[h].Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (trace));
+        }
+    }
+
+  for (uint32_t g = 0; g < groups.size (); ++g)
+    {
+      PointToPointHelper sinkLink;
+      sinkLink.SetDeviceAttribute ("DataRate", StringValue (COMMON_DATA_RATE));
+      sinkLink.SetChannelAttribute ("Delay", StringValue (groups[g].delay));
 
-  NetDeviceContainer d1d2 = highSpeedLink.Install (n1, n2); 
-  NetDeviceContainer d2d3 = bottleneckLink.Install (n2, n3);
-  NetDeviceContainer d3d4 = highSpeedLink.Install (n3, n4); 
-  NetDeviceContainer d3d5 = longDelayLink.Install (n3, n5); 
+      links.push_back (sinkLink.Install (routers.Get (groups[g].exitHop), sinks.Get (g)));
+    }
 
   InternetStackHelper stack;
-  stack.Install (nodes);
+  stack.Install (sources);
+  stack.Install (routers);
+  stack.Install (sinks);
 
-  //  3. IP Addressing and Routing (3 Networks) 
-  Ipv4AddressHelper address;
-  
-  address.SetBase ("10.1.1.0", "255.255.255.0");
-  address.Assign (d1d2);
+  for (uint32_t s = 0; s < sourceGroup.size (); ++s)
+    {
+      std::string protocol = groups[sourceGroup[s]].protocol;
+      if (protocol != transport_prot)
+        {
+          std::stringstream path;
+          path << "/NodeList/" << sources.Get (s)->GetId () << "/$ns3::TcpL4Protocol/SocketType";
+          Config::Set (path.str (), TypeIdValue (TypeId::LookupByName ("ns3::" + protocol)));
+        }
+    }
 
-  address.NewNetwork ();
-  address.SetBase ("10.2.2.0", "255.255.255.0");
-  address.Assign (d2d3);
+  //  3. IP Addressing and Routing (link k gets 10.k.k.0/24, in creation order)
+  Ipv4AddressHelper address;
+  std::vector<Ipv4Address> sinkIpAddresses;
 
-  address.NewNetwork ();
-  address.SetBase ("10.3.3.0", "255.255.255.0");
-  Ipv4InterfaceContainer i3i4 = address.Assign (d3d4);
+  for (uint32_t k = 0; k < links.size (); ++k)
+    {
+      std::ostringstream base;
+      base << "10." << k + 1 << "." << k + 1 << ".0";
+      address.SetBase (base.str ().c_str (), "255.255.255.0");
+      Ipv4InterfaceContainer interfaces = address.Assign (links[k]);
 
-  address.NewNetwork ();
-  address.SetBase ("10.4.4.0", "255.255.255.0");
-  Ipv4InterfaceContainer i3i5 = address.Assign (d3d5);
+      if (k >= sourceGroup.size () + nBottlenecks)
+        {
+          sinkIpAddresses.push_back (interfaces.GetAddress (1));
+        }
+    }
   
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
   
-  //  4. Application Setup (Heterogeneous Flows) 
+  //  4. Application Setup (Heterogeneous Flows)
+  //  Flow i uses destination port port + i; flowGroup and flowSinkIp are
+  //  indexed by that flow index and filled here, before the run.
   uint16_t port = 50000;
-  uint32_t numDest1Flows = nFlows / 2;
-  uint32_t numDest2Flows = nFlows / 2;
-  
-  Ipv4Address sink1IpAddress = i3i4.GetAddress (1); 
-  Ipv4Address sink2IpAddress = i3i5.GetAddress (1); 
+  std::vector<uint32_t> flowGroup;
+  std::vector<Ipv4Address> flowSinkIp;
+  std::vector<uint32_t> flowSocketIndex;
+  std::vector<uint32_t> sourceSockets (sourceGroup.size (), 0);
 
   ApplicationContainer sourceApps;
   ApplicationContainer sinkApps;
   
-  for (uint32_t i = 0; i < nFlows; ++i)
+  for (uint32_t g = 0; g < groups.size (); ++g)
     {
-      Ptr<Node> sinkNode;
-      Ipv4Address sinkIp;
-      uint16_t currentPort = port + i;
+      Ptr<Node> sourceNode = sources.Get (groupSource[g]);
 
-      if (i < numDest1Flows)
+      for (uint32_t j = 0; j < groups[g].nFlows; ++j)
         {
-          sinkNode = n4;
-          sinkIp = sink1IpAddress;
+          uint16_t currentPort = port + flowGroup.size ();
+
+          Address sinkLocalAddress (InetSocketAddress (Ipv4Address::GetAny (), currentPort));
+          PacketSinkHelper sinkHelper ("ns3::TcpSocketFactory", sinkLocalAddress);
+          sinkApps.Add (sinkHelper.Install (sinks.Get (g)));
+          
+          AddressValue remoteAddress (InetSocketAddress (sinkIpAddresses[g], currentPort));
+          BulkSendHelper ftp ("ns3::TcpSocketFactory", Address ());
+          ftp.SetAttribute ("Remote", remoteAddress);
+          ftp.SetAttribute ("SendSize", UintegerValue (536));
+          ftp.SetAttribute ("MaxBytes", UintegerValue (data_mbytes * 1000000));
+
+          sourceApps.Add (ftp.Install (sourceNode));
+
+          // BulkSend sockets are created in application order, so this is the
+          // flow's index in its source node's TCP SocketList.
+          flowGroup.push_back (g);
+          flowSinkIp.push_back (sinkIpAddresses[g]);
+          flowSocketIndex.push_back (sourceSockets[groupSource[g]]++);
         }
-      else
-        {
-          sinkNode = n5;
-          sinkIp = sink2IpAddress;
-        }
-
-      Address sinkLocalAddress (InetSocketAddress (Ipv4Address::GetAny (), currentPort));
-      PacketSinkHelper sinkHelper ("ns3::TcpSocketFactory", sinkLocalAddress);
-      sinkApps.Add (sinkHelper.Install (sinkNode));
-      
-      AddressValue remoteAddress (InetSocketAddress (sinkIp, currentPort));
-      BulkSendHelper ftp ("ns3::TcpSocketFactory", Address ());
-      ftp.SetAttribute ("Remote", remoteAddress);
-      ftp.SetAttribute ("SendSize", UintegerValue (536));
-      ftp.SetAttribute ("MaxBytes", UintegerValue (data_mbytes * 1000000));
-
-      sourceApps.Add (ftp.Install (n1));
     }
     
   sinkApps.Start (Seconds (SINK_START_TIME));
@@ -220,54 +447,133 @@ int main (int argc, char *argv[])
   sourceApps.Start (Seconds (FLOW_START_TIME));
   sourceApps.Stop (Seconds (SIMULATION_DURATION - 1));
 
-  //  5. Tracing and Flow Monitor 
+  //  5. Tracing and Flow Accounting
   double traceStartTime = FLOW_START_TIME + 0.00001; 
   for (uint32_t i = 0; i < nFlows; ++i)
     {
       std::stringstream flowIdStr;
       flowIdStr << "flow-" << i;
       std::string cwndFileName = "cwnd-trace-" + flowIdStr.str() + ".csv";
-      Simulator::Schedule (Seconds (traceStartTime), &TraceCwnd, cwndFileName, 0, i);
+      Simulator::Schedule (Seconds (traceStartTime), &TraceCwnd, cwndFileName,
+                           sources.Get (groupSource[flowGroup[i]])->GetId (), flowSocketIndex[i], i);
+
+      if (accounting == "probe" && probeStats)
+        {
+          Simulator::Schedule (Seconds (traceStartTime), &TraceProbeSocket,
+                               sources.Get (groupSource[flowGroup[i]])->GetId (), flowSocketIndex[i], i);
+        }
     }
 
   Ptr<FlowMonitor> flowMonitor;
   FlowMonitorHelper flowHelper;
-  flowMonitor = flowHelper.InstallAll ();
+  if (accounting == "flowmon")
+    {
+      flowMonitor = flowHelper.InstallAll ();
+    }
+  else
+    {
+      InstallFlowProbe (sinkApps, sourceApps, nFlows);
+    }
+
+  if (setupOnly)
+    {
+      Simulator::Destroy ();
+      return 0;
+    }
+
+  NetDeviceContainer bottleneckEgress;
+  for (NetDeviceContainer const& devices : bottleneckDevices)
+    {
+      bottleneckEgress.Add (devices.Get (0));
+    }
+
+  if (!telemetryTarget.empty ())
+    {
+      StartTelemetry (sinkApps, bottleneckEgress);
+    }
 
   //  6. Execution and Data Extraction 
   Simulator::Stop (Seconds (SIMULATION_DURATION));
   Simulator::Run ();
 
-  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
-  std::map<FlowId, FlowMonitor::FlowStats> stats = flowMonitor->GetFlowStats ();
+  if (!telemetryTarget.empty ())
+    {
+      StopTelemetry (sinkApps, bottleneckEgress);
+    }
 
-  double dest1Goodput = 0.0; 
-  double dest2Goodput = 0.0; 
-  
-  for (auto const& iter : stats)
+  std::vector<double> flowGoodput (nFlows, 0.0);
+  if (accounting == "flowmon")
     {
-      Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (iter.first);
-      
-      if (t.destinationAddress == Ipv4Address("10.3.3.2"))
+      Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowHelper.GetClassifier ());
+      std::map<FlowId, FlowMonitor::FlowStats> stats = flowMonitor->GetFlowStats ();
+
+      // Map each monitored flow back to its flow index through the destination
+      // port; ACK flows and anything not addressed to the flow's sink are skipped.
+      for (auto const& iter : stats)
         {
-          dest1Goodput += (double)iter.second.rxBytes * 8 / (SIMULATION_DURATION - FLOW_START_TIME) / 1000000.0;
+          Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (iter.first);
+          uint32_t flowIndex = t.destinationPort - port;
+
+          if (t.destinationPort >= port && flowIndex < nFlows && t.destinationAddress == flowSinkIp[flowIndex])
+            {
+              flowGoodput[flowIndex] += (double)iter.second.rxBytes * 8 / (SIMULATION_DURATION - FLOW_START_TIME) / 1000000.0;
+            }
         }
-      else if (t.destinationAddress == Ipv4Address("10.4.4.2"))
+    }
+  else
+    {
+      for (uint32_t i = 0; i < nFlows; ++i)
         {
-          dest2Goodput += (double)iter.second.rxBytes * 8 / (SIMULATION_DURATION - FLOW_START_TIME) / 1000000.0;
+          flowGoodput[i] = (double)flowProbe.rxBytes[i] * 8 / (SIMULATION_DURATION - FLOW_START_TIME) / 1000000.0;
         }
     }
 
-  double avgDest1Goodput = dest1Goodput / numDest1Flows;
-  double avgDest2Goodput = dest2Goodput / numDest2Flows;
+  std::vector<std::vector<double>> groupGoodputs (groups.size ());
+  for (uint32_t i = 0; i < nFlows; ++i)
+    {
+      groupGoodputs[flowGroup[i]].push_back (flowGoodput[i]);
+    }
 
   std::cout << " RTT Fairness Results \n";
-  std::cout << "Protocol: " << transport_prot << "\n";
+  if (groupSpec.empty ())
+    {
+      std::cout << "Protocol: " << transport_prot << "\n";
+    }
   std::cout << "NFlows: " << nFlows << "\n";
   std::cout << "RunIndex: " << runIndex << "\n";
-  std::cout << "Average Goodput (Dest 1 - Short RTT): " << avgDest1Goodput << " Mbps\n";
-  std::cout << "Average Goodput (Dest 2 - Long RTT): " << avgDest2Goodput << " Mbps\n";
+  std::cout << "Bottlenecks: " << nBottlenecks << "\n";
+
+  for (uint32_t g = 0; g < groups.size (); ++g)
+    {
+      double groupTotal = 0.0;
+      for (double goodput : groupGoodputs[g])
+        {
+          groupTotal += goodput;
+        }
+
+      std::cout << "Average Goodput (Group " << g + 1 << " - " << groups[g].delay << " "
+                << groups[g].protocol << "): " << groupTotal / groups[g].nFlows << " Mbps\n";
+      std::cout << "Jain Fairness (Group " << g + 1 << "): " << JainFairness (groupGoodputs[g]) << "\n";
+    }
+  std::cout << "Jain Fairness (All Flows): " << JainFairness (flowGoodput) << "\n";
+
+  uint64_t deliveredBytes = 0;
+  for (uint32_t i = 0; i < sinkApps.GetN (); ++i)
+    {
+      deliveredBytes += DynamicCast<PacketSink> (sinkApps.Get (i))->GetTotalRx ();
+    }
+  std::cout << "Delivered Bytes: " << deliveredBytes << "\n";
+
+  if (accounting == "probe" && probeStats)
+    {
+      for (uint32_t i = 0; i < nFlows; ++i)
+        {
+          std::cout << "Flow " << i + 1 << " (Group " << flowGroup[i] + 1 << "): ";
+          PrintProbeStats (i);
+          std::cout << "\n";
+        }
+    }
 
   Simulator::Destroy ();
   return 0;
-}
\ No newline at end of file
+}
@@ -3,6 +3,7 @@ import csv
 import re
 import time
 import os
+import signal
 import sys
 
 FLOW_COUNTS = [2, 4, 6, 8]
@@ -14,10 +15,54 @@ ERROR_RATE = 0.00001
 SIM_NAME = "lab2-part2" 
 OUTPUT_FILE = "part2_results.csv"
 
+# Each run publishes telemetry to this file; a run whose snapshot stops
+# changing for STALL_SECONDS of wall time is killed and its trial reported
+# as 0 so one hung simulation cannot block the sweep.
+TELEMETRY_FILE = f"/dev/shm/{SIM_NAME}-{os.getpid()}.tel"
+STALL_SECONDS = 120.0
+POLL_SECONDS = 1.0
+
+if not os.path.exists("scratch/lab2-common.h"):
+    print("FATAL ERROR: scratch/lab2-common.h not found. Run Lab2_mortimer_diogo/install-scratch.sh "
+          "<ns-3 root> first.")
+    sys.exit(1)
+
 SIM_EXECUTABLE = "./ns3 run " + SIM_NAME + " --"
 subprocess.run(SIM_EXECUTABLE.split()[:-1], check=True, capture_output=True) 
 
 
+def run_watched(cmd):
+    """
+    Runs the simulation while watching its telemetry file.
+    Returns stdout, or None if the run stalled and was killed.
+    """
+    # Own process group, so killing it also stops the simulator under ./ns3.
+    with open(os.devnull, 'w') as devnull, \
+         subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=devnull, text=True,
+                          start_new_session=True) as proc:
+        # stdout is read after the run; the summary is far below the pipe size.
+        last_mtime = None
+        last_change = time.time()
+        while proc.poll() is None:
+            try:
+                mtime = os.stat(TELEMETRY_FILE).st_mtime
+            except FileNotFoundError:
+                mtime = None
+            if mtime != last_mtime:
+                last_mtime = mtime
+                last_change = time.time()
+            elif time.time() - last_change > STALL_SECONDS:
+                os.killpg(proc.pid, signal.SIGKILL)
+                proc.wait()
+                return None
+            time.sleep(POLL_SECONDS)
+
+        output = proc.stdout.read()
+        if proc.returncode != 0:
+            raise subprocess.CalledProcessError(proc.returncode, cmd, output)
+        return output
+
+
 def run_single_simulation(n_flows, protocol, run_index):
     """
     Executes the ns-3 script with specific parameters and run index.
@@ -30,21 +75,19 @@ def run_single_simulation(n_flows, protocol, run_index):
         f"--dataRate={DATA_RATE}",
         f"--delay={BOTTLENECK_DELAY}",
         f"--errorRate={ERROR_RATE}",
-        f"--run={run_index}" 
+        f"--run={run_index}",
+        f"--telemetry={TELEMETRY_FILE}"
     ]
     
     cmd = SIM_EXECUTABLE.split() + args
 
-    result = subprocess.run(
-        cmd,
-        capture_output=True,
-        text=True,
-        check=True,
-    )
-    output = result.stdout
+    output = run_watched(cmd)
+    if output is None:
+        print(f"   -> WARNING: {protocol} run {run_index} stalled for {STALL_SECONDS:.0f}s and was killed.")
+        return 0.0, 0.0
     
-    match1 = re.search(r"Average Goodput \(Dest 1 - Short RTT\):\s*([\d.]+)\s*Mbps", output)
-    match2 = re.search(r"Average Goodput \(Dest 2 - Long RTT\):\s*([\d.]+)\s*Mbps", output)
+    match1 = re.search(r"Average Goodput \(Group 1 - [^)]*\):\s*([\d.]+)\s*Mbps", output)
+    match2 = re.search(r"Average Goodput \(Group 2 - [^)]*\):\s*([\d.]+)\s*Mbps", output)
     
     if match1 and match2:
         return float(match1.group(1)), float(match2.group(1))
@@ -88,6 +131,9 @@ def main():
     
     end_time = time.time()
     
+    if os.path.exists(TELEMETRY_FILE):
+        os.remove(TELEMETRY_FILE)
+
     with open(OUTPUT_FILE, 'w', newline='') as f:
         writer = csv.writer(f)
         writer.writerows(results)
@@ -0,0 +1,86 @@
+import os
+import socket
+import sys
+import time
+
+# Usage:
+#   python3 watch-telemetry.py /dev/shm/lab2.tel          (file target)
+#   python3 watch-telemetry.py unix:/tmp/lab2.sock        (socket target)
+# and start the simulation with the same value in --telemetry.
+
+STALL_SECONDS = 30.0
+POLL_SECONDS = 1.0
+
+
+def parse_snapshot(line):
+    """Parses a 'key=value key=value ...' telemetry line into a dict."""
+    return dict(field.split("=", 1) for field in line.split())
+
+
+def show(snapshot):
+    print(f"sim {float(snapshot['simTime']):7.1f}s | wall {float(snapshot['wallTime']):8.1f}s | "
+          f"{float(snapshot['eventsPerSec']):10.0f} ev/s | "
+          f"{float(snapshot['goodputMbps']):8.4f} Mbps | queue {snapshot['queueDepth']:>4}", flush=True)
+
+
+def watch_file(path):
+    # Snapshots written before the watcher started belong to an earlier run.
+    start = time.time()
+    last_mtime = None
+    last_change = start
+    while True:
+        try:
+            mtime = os.stat(path).st_mtime
+        except FileNotFoundError:
+            mtime = None
+
+        if mtime is not None and mtime >= start and mtime != last_mtime:
+            last_mtime = mtime
+            last_change = time.time()
+            with open(path) as f:
+                snapshot = parse_snapshot(f.read())
+            show(snapshot)
+            if snapshot.get("state") == "done":
+                return
+        elif time.time() - last_change > STALL_SECONDS:
+            print(f"WARNING: no telemetry for {STALL_SECONDS:.0f}s, run may be hung.", flush=True)
+            last_change = time.time()
+
+        time.sleep(POLL_SECONDS)
+
+
+def watch_socket(path):
+    if os.path.exists(path):
+        os.remove(path)
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+    sock.bind(path)
+    sock.settimeout(STALL_SECONDS)
+    try:
+        while True:
+            try:
+                data = sock.recv(4096)
+            except socket.timeout:
+                print(f"WARNING: no telemetry for {STALL_SECONDS:.0f}s, run may be hung.", flush=True)
+                continue
+            snapshot = parse_snapshot(data.decode())
+            show(snapshot)
+            if snapshot.get("state") == "done":
+                return
+    finally:
+        sock.close()
+        os.remove(path)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: watch-telemetry.py <file | unix:socket-path>")
+        sys.exit(1)
+
+    target = sys.argv[1]
+    if target.startswith("unix:"):
+        watch_socket(target[len("unix:"):])
+    else:
+        watch_file(target)
+
+if __name__ == "__main__":
+    main()
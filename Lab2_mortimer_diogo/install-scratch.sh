@@ -0,0 +1,26 @@
+#!/bin/sh
+# Copies the lab2 programs into an ns-3 tree in the layout they expect:
+#   scratch/lab2-common.h
+#   scratch/lab2-part1/lab2-part1.cc
+#   scratch/lab2-part2/lab2-part2.cc
+# Usage: ./install-scratch.sh <ns-3 root>   (then ./ns3 build)
+set -e
+
+if [ $# -ne 1 ] || [ ! -d "$1/scratch" ]; then
+    echo "Usage: $0 <ns-3 root>" >&2
+    exit 1
+fi
+
+LAB_DIR=$(cd "$(dirname "$0")" && pwd)
+SCRATCH="$1/scratch"
+
+cp "$LAB_DIR/lab2-common.h" "$SCRATCH/lab2-common.h"
+for part in 1 2; do
+    # A single-file copy from the old layout would build a second program
+    # with the same name.
+    rm -f "$SCRATCH/lab2-part$part.cc"
+    mkdir -p "$SCRATCH/lab2-part$part"
+    cp "$LAB_DIR/Part$part/lab2-part$part.cc" "$SCRATCH/lab2-part$part/lab2-part$part.cc"
+done
+
+echo "Installed lab2-part1 and lab2-part2 into $SCRATCH"
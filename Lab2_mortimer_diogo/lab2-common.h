@@ -0,0 +1,490 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LAB2_COMMON_H
+#define LAB2_COMMON_H
+
+// Helpers shared by lab2-part1 and lab2-part2. Both programs include this
+// header as "../lab2-common.h", so in an ns-3 tree each program lives in its
+// own scratch subdirectory (scratch/lab2-part1/, scratch/lab2-part2/) with
+// this header in scratch/. install-scratch.sh sets that layout up.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/error-model.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/tcp-option-ts.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+
+namespace ns3 {
+
+// Lightweight flow accounting. Trace sinks are bound to the flow index when
+// the applications are created, so counters live in flat arrays and no packet
+// is ever classified; only the chosen source and sink nodes are instrumented.
+struct FlowProbe
+{
+  std::vector<uint64_t> rxBytes;
+  std::vector<uint64_t> rxPackets;
+  std::vector<uint64_t> txBytes;
+  std::vector<uint64_t> txSegments;
+  std::vector<uint64_t> retxSegments;
+  std::vector<uint32_t> highestTxSeq;
+  std::vector<SequenceNumber32> highestAck;
+  std::vector<double> ackRttSum;
+  std::vector<uint64_t> ackRttSamples;
+};
+
+static FlowProbe flowProbe;
+
+static void
+ProbeSinkRx (uint32_t flowId, Ptr<const Packet> packet, const Address &from)
+{
+  flowProbe.rxBytes[flowId] += packet->GetSize ();
+  flowProbe.rxPackets[flowId]++;
+}
+
+static void
+ProbeSourceTx (uint32_t flowId, Ptr<const Packet> packet)
+{
+  flowProbe.txBytes[flowId] += packet->GetSize ();
+}
+
+static void
+ProbeSocketTx (uint32_t flowId, Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket)
+{
+  if (packet->GetSize () == 0)
+    {
+      return;
+    }
+
+  // A data segment that starts below the highest sequence already sent is a retransmission.
+  uint32_t seq = header.GetSequenceNumber ().GetValue ();
+  flowProbe.txSegments[flowId]++;
+  if (seq < flowProbe.highestTxSeq[flowId])
+    {
+      flowProbe.retxSegments[flowId]++;
+    }
+  flowProbe.highestTxSeq[flowId] = std::max (flowProbe.highestTxSeq[flowId], seq + packet->GetSize ());
+}
+
+// One RTT sample per ACK that acknowledges new data and echoes a TCP timestamp
+// (millisecond resolution). Duplicate ACKs echo the timestamp of the last
+// in-order segment and would inflate the mean, so they are skipped; the
+// SYN-ACK only sets the starting acknowledgement number.
+static void
+ProbeSocketRx (uint32_t flowId, Ptr<const Packet> packet, const TcpHeader &header, Ptr<const TcpSocketBase> socket)
+{
+  if (!(header.GetFlags () & TcpHeader::ACK))
+    {
+      return;
+    }
+
+  SequenceNumber32 ack = header.GetAckNumber ();
+  if (header.GetFlags () & TcpHeader::SYN)
+    {
+      flowProbe.highestAck[flowId] = ack;
+      return;
+    }
+  if (ack <= flowProbe.highestAck[flowId])
+    {
+      return;
+    }
+  flowProbe.highestAck[flowId] = ack;
+
+  if (!header.HasOption (TcpOption::TS))
+    {
+      return;
+    }
+
+  Ptr<const TcpOptionTS> ts = DynamicCast<const TcpOptionTS> (header.GetOption (TcpOption::TS));
+  flowProbe.ackRttSum[flowId] += TcpOptionTS::ElapsedTimeFromTsValue (ts->GetEcho ()).GetSeconds ();
+  flowProbe.ackRttSamples[flowId]++;
+}
+
+static void
+InstallFlowProbe (ApplicationContainer sinkApps, ApplicationContainer sourceApps, uint32_t nFlows)
+{
+  flowProbe.rxBytes.assign (nFlows, 0);
+  flowProbe.rxPackets.assign (nFlows, 0);
+  flowProbe.txBytes.assign (nFlows, 0);
+  flowProbe.txSegments.assign (nFlows, 0);
+  flowProbe.retxSegments.assign (nFlows, 0);
+  flowProbe.highestTxSeq.assign (nFlows, 0);
+  flowProbe.highestAck.assign (nFlows, SequenceNumber32 (0));
+  flowProbe.ackRttSum.assign (nFlows, 0.0);
+  flowProbe.ackRttSamples.assign (nFlows, 0);
+
+  for (uint32_t i = 0; i < nFlows; ++i)
+    {
+      sinkApps.Get (i)->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&ProbeSinkRx, i));
+      sourceApps.Get (i)->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&ProbeSourceTx, i));
+    }
+}
+
+// Socket-level delay and loss statistics; the sockets only exist once the
+// sources have started, so this is scheduled like the cwnd tracing.
+static void
+TraceProbeSocket (uint32_t nodeId, uint32_t socketIndex, uint32_t flowId)
+{
+  std::stringstream path;
+  path << "/NodeList/" << nodeId << "/$ns3::TcpL4Protocol/SocketList/" << socketIndex;
+
+  Config::ConnectWithoutContext (path.str () + "/Tx", MakeBoundCallback (&ProbeSocketTx, flowId));
+  Config::ConnectWithoutContext (path.str () + "/Rx", MakeBoundCallback (&ProbeSocketRx, flowId));
+}
+
+// Per-flow probe statistics: mean ACK RTT, retransmitted segments (the loss
+// estimate), and the application bytes handed to TCP but not yet received by
+// the sink, which at the end of the run are mostly still in the send buffer.
+static void
+PrintProbeStats (uint32_t flowId)
+{
+  double meanRtt = flowProbe.ackRttSamples[flowId] > 0
+    ? flowProbe.ackRttSum[flowId] / flowProbe.ackRttSamples[flowId] : 0.0;
+  double retxRate = flowProbe.txSegments[flowId] > 0
+    ? (double) flowProbe.retxSegments[flowId] / flowProbe.txSegments[flowId] : 0.0;
+
+  std::cout << "Mean ACK RTT " << meanRtt * 1000 << " ms"
+            << ", Retransmitted " << flowProbe.retxSegments[flowId] << "/" << flowProbe.txSegments[flowId] << " segments"
+            << " (" << retxRate * 100 << "%)"
+            << ", Sent " << flowProbe.txBytes[flowId] << " bytes"
+            << ", Received " << flowProbe.rxBytes[flowId] << " bytes in " << flowProbe.rxPackets[flowId] << " packets"
+            << ", Queued/in flight " << flowProbe.txBytes[flowId] - flowProbe.rxBytes[flowId] << " bytes";
+}
+
+// Loss models that give every protocol the same impairments. Both are meant to
+// be installed only on the forward receive side of the bottleneck, so their
+// packet index counts data segments alone and is not shifted by ACK traffic.
+const int64_t LOSS_MODEL_STREAM = 1000;
+
+// Default byte error rate of the rate model. errorRate is only meaningful with
+// lossModel=rate; any other value with gilbert or trace is rejected.
+const double DEFAULT_ERROR_RATE = 0.00001;
+
+// Two-state Gilbert-Elliott model. The chain advances once per packet and every
+// packet consumes exactly two draws from a dedicated stream, so the loss
+// pattern is a function of the packet index for a given seed and run.
+class GilbertElliottErrorModel : public ErrorModel
+{
+public:
+  GilbertElliottErrorModel ();
+
+  static TypeId GetTypeId (void);
+  void Setup (double pGoodToBad, double pBadToGood, double lossGood, double lossBad, int64_t stream);
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  Ptr<UniformRandomVariable> m_uniform;
+  double m_pGoodToBad;
+  double m_pBadToGood;
+  double m_lossGood;
+  double m_lossBad;
+  bool m_bad;
+};
+
+GilbertElliottErrorModel::GilbertElliottErrorModel ()
+  : m_uniform (CreateObject<UniformRandomVariable> ()),
+    m_pGoodToBad (0),
+    m_pBadToGood (1),
+    m_lossGood (0),
+    m_lossBad (0),
+    m_bad (false)
+{
+}
+
+TypeId
+GilbertElliottErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("GilbertElliottErrorModel")
+    .SetParent<ErrorModel> ()
+    .SetGroupName ("Lab2")
+    .AddConstructor<GilbertElliottErrorModel> ()
+    ;
+  return tid;
+}
+
+void
+GilbertElliottErrorModel::Setup (double pGoodToBad, double pBadToGood, double lossGood, double lossBad, int64_t stream)
+{
+  m_pGoodToBad = pGoodToBad;
+  m_pBadToGood = pBadToGood;
+  m_lossGood = lossGood;
+  m_lossBad = lossBad;
+  m_uniform->SetStream (stream);
+}
+
+bool
+GilbertElliottErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  double transition = m_uniform->GetValue ();
+  double loss = m_uniform->GetValue ();
+  m_bad = m_bad ? transition >= m_pBadToGood : transition < m_pGoodToBad;
+  return loss < (m_bad ? m_lossBad : m_lossGood);
+}
+
+void
+GilbertElliottErrorModel::DoReset (void)
+{
+  m_bad = false;
+}
+
+// Replays a precomputed loss schedule. The trace file lists the 0-based indices
+// of the packets to drop, one per line ('#' starts a comment), and must state
+// how many packets it covers with a "packets=<n>" token in a comment. It is
+// loaded into a bitmap so the per-packet check is a single bit test; running
+// past the covered range is fatal rather than silently loss-free.
+const uint64_t MAX_TRACE_PACKETS = 100000000;
+class TraceErrorModel : public ErrorModel
+{
+public:
+  TraceErrorModel ();
+
+  static TypeId GetTypeId (void);
+  void LoadTrace (std::string fileName);
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  std::vector<uint64_t> m_lossBits;
+  uint64_t m_coverage;
+  uint64_t m_index;
+};
+
+TraceErrorModel::TraceErrorModel ()
+  : m_coverage (0),
+    m_index (0)
+{
+}
+
+TypeId
+TraceErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("TraceErrorModel")
+    .SetParent<ErrorModel> ()
+    .SetGroupName ("Lab2")
+    .AddConstructor<TraceErrorModel> ()
+    ;
+  return tid;
+}
+
+void
+TraceErrorModel::LoadTrace (std::string fileName)
+{
+  std::ifstream in (fileName.c_str ());
+  if (!in)
+    {
+      NS_FATAL_ERROR ("Could not open loss trace file " << fileName);
+    }
+
+  std::vector<uint64_t> losses;
+  m_coverage = 0;
+  std::string line;
+  while (std::getline (in, line))
+    {
+      std::size_t const comment = line.find ('#');
+      if (comment != std::string::npos)
+        {
+          std::size_t const key = line.find ("packets=", comment);
+          if (key != std::string::npos)
+            {
+              std::istringstream (line.substr (key + 8)) >> m_coverage;
+            }
+        }
+
+      std::istringstream fields (line.substr (0, comment));
+      uint64_t index;
+      if (fields >> index)
+        {
+          losses.push_back (index);
+        }
+    }
+
+  if (m_coverage == 0 || m_coverage > MAX_TRACE_PACKETS)
+    {
+      NS_FATAL_ERROR ("Loss trace " << fileName << " must declare packets=<n> with 0 < n <= " << MAX_TRACE_PACKETS);
+    }
+
+  m_lossBits.assign ((m_coverage + 63) / 64, 0);
+  for (uint64_t index : losses)
+    {
+      if (index >= m_coverage)
+        {
+          NS_FATAL_ERROR ("Loss trace " << fileName << " drops packet " << index
+                          << " outside its declared coverage of " << m_coverage << " packets");
+        }
+      m_lossBits[index / 64] |= (uint64_t)1 << (index % 64);
+    }
+}
+
+bool
+TraceErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  uint64_t index = m_index++;
+  if (index >= m_coverage)
+    {
+      NS_FATAL_ERROR ("Loss trace covers only " << m_coverage << " packets; regenerate it with more packets");
+    }
+  return (m_lossBits[index / 64] >> (index % 64)) & 1;
+}
+
+void
+TraceErrorModel::DoReset (void)
+{
+  m_index = 0;
+}
+
+// Opt-in telemetry: every TELEMETRY_INTERVAL of simulated time a one-line
+// snapshot is published either to a file (replaced atomically, e.g. under
+// /dev/shm) or, with a "unix:" prefix, as a datagram to a Unix socket. It is
+// meant for the long lab2 runs; run-part2.py uses the file target to detect
+// stalled runs and watch-telemetry.py follows a single run by hand.
+const double TELEMETRY_INTERVAL = 1.0;
+
+static std::string telemetryTarget;
+static int telemetrySocket = -1;
+static std::chrono::steady_clock::time_point telemetryWallStart;
+static std::chrono::steady_clock::time_point telemetryLastWall;
+static double telemetryLastSimTime = 0.0;
+static uint64_t telemetryLastEvents = 0;
+static uint64_t telemetryLastRxBytes = 0;
+
+static void
+PublishTelemetry (std::string snapshot)
+{
+  if (telemetryTarget.compare (0, 5, "unix:") == 0)
+    {
+      struct sockaddr_un addr;
+      std::memset (&addr, 0, sizeof (addr));
+      addr.sun_family = AF_UNIX;
+      std::strncpy (addr.sun_path, telemetryTarget.c_str () + 5, sizeof (addr.sun_path) - 1);
+
+      // Best effort: a missing or slow reader must never stall the simulation.
+      sendto (telemetrySocket, snapshot.c_str (), snapshot.size (), MSG_DONTWAIT,
+              (struct sockaddr *) &addr, sizeof (addr));
+    }
+  else
+    {
+      std::string tmpPath = telemetryTarget + ".tmp";
+      std::ofstream out (tmpPath.c_str (), std::ios::trunc);
+      out << snapshot;
+      out.close ();
+      std::rename (tmpPath.c_str (), telemetryTarget.c_str ());
+    }
+}
+
+static uint32_t
+GetQueueDepth (NetDeviceContainer devices)
+{
+  uint32_t depth = 0;
+  for (uint32_t i = 0; i < devices.GetN (); ++i)
+    {
+      Ptr<NetDevice> device = devices.Get (i);
+      Ptr<PointToPointNetDevice> p2p = DynamicCast<PointToPointNetDevice> (device);
+      if (p2p)
+        {
+          depth += p2p->GetQueue ()->GetNPackets ();
+        }
+
+      Ptr<TrafficControlLayer> tc = device->GetNode ()->GetObject<TrafficControlLayer> ();
+      if (tc && tc->GetRootQueueDiscOnDevice (device))
+        {
+          depth += tc->GetRootQueueDiscOnDevice (device)->GetNPackets ();
+        }
+    }
+  return depth;
+}
+
+static void
+TelemetrySample (ApplicationContainer sinkApps, NetDeviceContainer queueDevices, std::string state)
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now ();
+  double wallTime = std::chrono::duration<double> (now - telemetryWallStart).count ();
+  double wallDelta = std::chrono::duration<double> (now - telemetryLastWall).count ();
+  double simTime = Simulator::Now ().GetSeconds ();
+  double simDelta = simTime - telemetryLastSimTime;
+  uint64_t events = Simulator::GetEventCount ();
+
+  uint64_t rxBytes = 0;
+  for (uint32_t i = 0; i < sinkApps.GetN (); ++i)
+    {
+      rxBytes += DynamicCast<PacketSink> (sinkApps.Get (i))->GetTotalRx ();
+    }
+
+  std::ostringstream snapshot;
+  snapshot << "state=" << state
+           << " simTime=" << simTime
+           << " wallTime=" << wallTime
+           << " eventsPerSec=" << (wallDelta > 0 ? (events - telemetryLastEvents) / wallDelta : 0.0)
+           << " goodputMbps=" << (simDelta > 0 ? (double)(rxBytes - telemetryLastRxBytes) * 8 / simDelta / 1000000.0 : 0.0)
+           << " queueDepth=" << GetQueueDepth (queueDevices)
+           << "\n";
+  PublishTelemetry (snapshot.str ());
+
+  telemetryLastWall = now;
+  telemetryLastSimTime = simTime;
+  telemetryLastEvents = events;
+  telemetryLastRxBytes = rxBytes;
+
+  if (state == "running")
+    {
+      Simulator::Schedule (Seconds (TELEMETRY_INTERVAL), &TelemetrySample, sinkApps, queueDevices, state);
+    }
+}
+
+static void
+StartTelemetry (ApplicationContainer sinkApps, NetDeviceContainer queueDevices)
+{
+  // Drop a snapshot left by an earlier run so readers never see stale data.
+  if (telemetryTarget.compare (0, 5, "unix:") != 0)
+    {
+      std::remove (telemetryTarget.c_str ());
+    }
+  else
+    {
+      telemetrySocket = socket (AF_UNIX, SOCK_DGRAM, 0);
+      if (telemetrySocket < 0)
+        {
+          std::cerr << "WARNING: could not create telemetry socket (" << std::strerror (errno)
+                    << "), telemetry disabled." << std::endl;
+          telemetryTarget.clear ();
+          return;
+        }
+    }
+
+  telemetryWallStart = std::chrono::steady_clock::now ();
+  telemetryLastWall = telemetryWallStart;
+  Simulator::Schedule (Seconds (TELEMETRY_INTERVAL), &TelemetrySample, sinkApps, queueDevices,
+                       std::string ("running"));
+}
+
+static void
+StopTelemetry (ApplicationContainer sinkApps, NetDeviceContainer queueDevices)
+{
+  TelemetrySample (sinkApps, queueDevices, "done");
+  if (telemetrySocket >= 0)
+    {
+      close (telemetrySocket);
+      telemetrySocket = -1;
+    }
+}
+
+} // namespace ns3
+
+#endif /* LAB2_COMMON_H */